@@ -0,0 +1,38 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new to count heap allocations, so benchmarks
+// can report allocations per iteration. The replacement applies to the whole
+// blink_bench executable: every benchmark, including the GDAL and
+// multi-threaded ones, pays one relaxed atomic increment per allocation.
+
+namespace {
+std::atomic<std::int64_t> count{ 0 };
+} // anonymous namespace
+
+std::int64_t allocation_count()
+{
+  return count.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+  count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size))
+  {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
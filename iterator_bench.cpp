@@ -0,0 +1,628 @@
+#include <benchmark/benchmark.h>
+
+#include <blink/iterator/any_proxy_reference.h>
+#include <blink/iterator/any_input_iterator.h>
+#include <blink/iterator/any_input_range.h>
+#include <blink/iterator/any_range_algebra_operators.h>
+#include <blink/iterator/range_algebra.h>
+#include <blink/iterator/range_algebra_operators.h>
+#include <blink/iterator/range_range.h>
+#include <blink/iterator/transform_range.h>
+#include <blink/iterator/zip_iterator.h>
+#include <blink/iterator/zip_range.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Iterator benchmarks over std::vector<int>. Where blink adds a layer over
+// contiguous memory, a hand-written loop over the same data is the baseline.
+
+// Heap allocations so far, counted by the replacement operator new in
+// allocation_count.cpp
+std::int64_t allocation_count();
+
+namespace {
+
+struct plus_op
+{
+  static constexpr int operands = 2;
+
+  template<class A, class B>
+  auto operator()(A&& a, B&& b) const -> decltype(a + b)
+  {
+    return a + b;
+  }
+};
+
+struct minus_op
+{
+  static constexpr int operands = 2;
+
+  template<class A, class B>
+  auto operator()(A&& a, B&& b) const -> decltype(a - b)
+  {
+    return a - b;
+  }
+};
+
+struct multiplies_op
+{
+  static constexpr int operands = 2;
+
+  template<class A, class B>
+  auto operator()(A&& a, B&& b) const -> decltype(a * b)
+  {
+    return a * b;
+  }
+};
+
+struct divides_op
+{
+  static constexpr int operands = 2;
+
+  template<class A, class B>
+  auto operator()(A&& a, B&& b) const -> decltype(a / b)
+  {
+    return a / b;
+  }
+};
+
+struct modulus_op
+{
+  static constexpr int operands = 2;
+
+  template<class A, class B>
+  auto operator()(A&& a, B&& b) const -> decltype(a % b)
+  {
+    return a % b;
+  }
+};
+
+struct negate_op
+{
+  static constexpr int operands = 1;
+
+  template<class A, class B>
+  auto operator()(A&& a, B&&) const -> decltype(-a)
+  {
+    return -a;
+  }
+};
+
+struct less_op
+{
+  static constexpr int operands = 2;
+
+  template<class A, class B>
+  auto operator()(A&& a, B&& b) const -> decltype(a < b)
+  {
+    return a < b;
+  }
+};
+
+struct equal_to_op
+{
+  static constexpr int operands = 2;
+
+  template<class A, class B>
+  auto operator()(A&& a, B&& b) const -> decltype(a == b)
+  {
+    return a == b;
+  }
+};
+
+// The expression of test_range_algebra_operators, five binary operators and
+// three references to a
+struct compound_op
+{
+  static constexpr int operands = 2;
+
+  template<class A, class B>
+  auto operator()(A&& a, B&& b) const
+    -> decltype(-a + 5 * b - a * 3 / b + a % 7)
+  {
+    return -a + 5 * b - a * 3 / b + a % 7;
+  }
+};
+
+std::vector<int> make_count_vector(std::int64_t size, int first = 0)
+{
+  std::vector<int> v(static_cast<std::size_t>(size));
+  std::iota(v.begin(), v.end(), first);
+  return v;
+}
+
+// Values first + (i % 1000), small enough that no operator benchmarked here
+// overflows int, and never zero for first >= 1
+std::vector<int> make_bounded_vector(std::int64_t size, int first = 0)
+{
+  std::vector<int> v(static_cast<std::size_t>(size));
+  for (std::size_t i = 0; i < v.size(); ++i)
+  {
+    v[i] = first + static_cast<int>(i % 1000);
+  }
+  return v;
+}
+
+void set_throughput(benchmark::State& state, std::int64_t elements,
+  std::int64_t bytes_per_element)
+{
+  state.SetItemsProcessed(state.iterations() * elements);
+  state.SetBytesProcessed(state.iterations() * elements * bytes_per_element);
+}
+
+void set_allocations(benchmark::State& state, std::int64_t allocations)
+{
+  state.counters["allocations"] = benchmark::Counter(
+    static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+void vector_sizes(benchmark::internal::Benchmark* b)
+{
+  b->ArgName("size");
+  b->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+}
+
+// Stacks of yearly layers, such as the 200+ of our time series
+void stack_sizes(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({ "layers", "pixels" });
+  b->ArgsProduct({ { 16, 200 }, { 1 << 12, 1 << 16 } });
+}
+
+// The passes with one chunk are the single-threaded baselines
+void chunk_counts(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({ "size", "chunks" });
+  b->ArgsProduct({ { 1 << 22, 1 << 24 }, { 1, 2, 4, 8 } });
+  b->UseRealTime();
+}
+
+// Threads started once that each run job(worker) once per round, so timed
+// rounds do not pay for thread creation and joining
+class round_pool
+{
+public:
+  round_pool(int workers, std::function<void(int)> job)
+    : m_job(std::move(job))
+  {
+    for (int k = 0; k < workers; ++k)
+    {
+      m_threads.emplace_back([this, k]() { work(k); });
+    }
+  }
+  round_pool(const round_pool&) = delete;
+  round_pool& operator=(const round_pool&) = delete;
+  ~round_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_start.notify_all();
+    for (auto&& t : m_threads)
+    {
+      t.join();
+    }
+  }
+
+  // Runs one round on all workers and waits until it is complete
+  void run_round()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_pending = static_cast<int>(m_threads.size());
+    ++m_round;
+    m_start.notify_all();
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+  }
+
+private:
+  void work(int k)
+  {
+    int seen_round = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+      m_start.wait(lock, [&]() { return m_stop || m_round != seen_round; });
+      if (m_stop) return;
+      seen_round = m_round;
+      lock.unlock();
+      m_job(k);
+      lock.lock();
+      if (--m_pending == 0) m_done.notify_one();
+    }
+  }
+
+  std::function<void(int)> m_job;
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_start;
+  std::condition_variable m_done;
+  int m_round = 0;
+  int m_pending = 0;
+  bool m_stop = false;
+};
+
+} // anonymous namespace
+
+template<class Op>
+void BM_range_algebra_vector(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  std::vector<int> a = make_bounded_vector(size);
+  std::vector<int> b = make_bounded_vector(size, 1); // divisor
+  std::vector<int> c(a.size());
+  auto ra = blink::iterator::range_algebra_ref(a);
+  auto rb = blink::iterator::range_algebra_ref(b);
+  auto rc = blink::iterator::range_algebra_ref(c);
+  for (auto _ : state)
+  {
+    rc = Op{}(ra, rb);
+    benchmark::ClobberMemory();
+  }
+  set_throughput(state, size, (Op::operands + 1) * sizeof(int));
+}
+
+template<class Op>
+void BM_raw_loop_vector(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  std::vector<int> a = make_bounded_vector(size);
+  std::vector<int> b = make_bounded_vector(size, 1); // divisor
+  std::vector<int> c(a.size());
+  for (auto _ : state)
+  {
+    for (std::size_t i = 0; i < c.size(); ++i)
+    {
+      c[i] = Op{}(a[i], b[i]);
+    }
+    benchmark::ClobberMemory();
+  }
+  set_throughput(state, size, (Op::operands + 1) * sizeof(int));
+}
+
+// Sum through the type-erased range, one virtual call per step
+void BM_any_input_range_sum(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  std::vector<int> v = make_count_vector(size);
+  blink::iterator::any_input_range<int> r(v);
+  for (auto _ : state)
+  {
+    std::int64_t sum = 0;
+    for (auto&& i : r)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_throughput(state, size, sizeof(int));
+}
+
+// Sum of two type-erased ranges, as in test_any_range_algebra
+void BM_any_range_algebra_sum(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  std::vector<int> a = make_count_vector(size);
+  std::vector<int> b = make_count_vector(size, 1);
+  blink::iterator::any_input_range<int> aa(a);
+  blink::iterator::any_input_range<int> bb(b);
+  for (auto _ : state)
+  {
+    auto cc = blink::iterator::range_algebra_ref(aa)
+      + blink::iterator::range_algebra_ref(bb);
+    std::int64_t sum = 0;
+    for (auto&& i : cc)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_throughput(state, size, 2 * sizeof(int));
+}
+
+// Splits a zip of two vectors into chunks by random access on zip_iterator,
+// one pool thread per chunk. This is the split that zip_range and
+// transform_range should offer directly.
+void BM_zip_iterator_chunks(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  const int chunks = static_cast<int>(state.range(1));
+  std::vector<int> a = make_count_vector(size);
+  std::vector<int> b = make_count_vector(size, 1);
+  std::vector<std::int64_t> sums(chunks, 0);
+  round_pool pool(chunks, [&](int k) {
+    const std::int64_t first = size * k / chunks;
+    const std::int64_t last = size * (k + 1) / chunks;
+    auto i = blink::iterator::make_zip_iterator(a.begin(), b.begin());
+    auto e = blink::iterator::make_zip_iterator(a.begin(), b.begin());
+    i += first;
+    e += last;
+    std::int64_t sum = 0;
+    for (; i != e; ++i)
+    {
+      sum += std::get<0>(*i) + std::get<1>(*i);
+    }
+    sums[k] = sum;
+  });
+  for (auto _ : state)
+  {
+    pool.run_round();
+    benchmark::DoNotOptimize(sums.data());
+  }
+  set_throughput(state, size, 2 * sizeof(int));
+}
+
+// The same split on the iterators of a transform_range of two vectors
+void BM_transform_range_chunks(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  const int chunks = static_cast<int>(state.range(1));
+  std::vector<int> a = make_count_vector(size);
+  std::vector<int> b = make_count_vector(size, 1);
+  auto tr = blink::iterator::make_transform_range(std::plus<>{}, a, b);
+  std::vector<std::int64_t> sums(chunks, 0);
+  round_pool pool(chunks, [&](int k) {
+    const std::int64_t first = size * k / chunks;
+    const std::int64_t last = size * (k + 1) / chunks;
+    auto i = tr.begin();
+    auto e = tr.begin();
+    i += first;
+    e += last;
+    std::int64_t sum = 0;
+    for (; i != e; ++i)
+    {
+      sum += *i;
+    }
+    sums[k] = sum;
+  });
+  for (auto _ : state)
+  {
+    pool.run_round();
+    benchmark::DoNotOptimize(sums.data());
+  }
+  set_throughput(state, size, 2 * sizeof(int));
+}
+
+// Sum of products over a zip_range of two vectors, as in test_zip_range_ref
+void BM_zip_range_sumproduct(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  std::vector<int> a = make_count_vector(size);
+  std::vector<int> b = make_count_vector(size, 1);
+  auto z = blink::iterator::make_zip_range(std::ref(a), std::ref(b));
+  for (auto _ : state)
+  {
+    std::int64_t sum = 0;
+    for (auto&& i : z)
+    {
+      sum += std::int64_t{ std::get<0>(i) } * std::get<1>(i);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_throughput(state, size, 2 * sizeof(int));
+}
+
+// The same sum of products as a loop over raw pointers, which compilers
+// vectorize
+void BM_raw_pointer_sumproduct(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  std::vector<int> a = make_count_vector(size);
+  std::vector<int> b = make_count_vector(size, 1);
+  for (auto _ : state)
+  {
+    const int* pa = a.data();
+    const int* pb = b.data();
+    std::int64_t sum = 0;
+    for (std::int64_t i = 0; i < size; ++i)
+    {
+      sum += std::int64_t{ pa[i] } * pb[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_throughput(state, size, 2 * sizeof(int));
+}
+
+// Six-way zip of equal-length vectors, where the end check of zip_range
+// compares all six component iterators on each step
+void BM_zip_range_six_way(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  std::vector<int> a = make_count_vector(size);
+  std::vector<int> b = make_count_vector(size, 1);
+  std::vector<int> c = make_count_vector(size, 2);
+  std::vector<int> d = make_count_vector(size, 3);
+  std::vector<int> e = make_count_vector(size, 4);
+  std::vector<int> f = make_count_vector(size, 5);
+  auto z = blink::iterator::make_zip_range(std::ref(a), std::ref(b),
+    std::ref(c), std::ref(d), std::ref(e), std::ref(f));
+  for (auto _ : state)
+  {
+    std::int64_t sum = 0;
+    for (auto&& i : z)
+    {
+      sum += std::get<0>(i) + std::get<1>(i) + std::get<2>(i)
+        + std::get<3>(i) + std::get<4>(i) + std::get<5>(i);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_throughput(state, size, 6 * sizeof(int));
+}
+
+// The same six-way sum through one zip_iterator, advanced size steps with
+// a single counter as the end check. The tuple proxy stays, so the gap to
+// BM_zip_range_six_way is what zip_equal would save.
+void BM_zip_iterator_six_way_counted(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  std::vector<int> a = make_count_vector(size);
+  std::vector<int> b = make_count_vector(size, 1);
+  std::vector<int> c = make_count_vector(size, 2);
+  std::vector<int> d = make_count_vector(size, 3);
+  std::vector<int> e = make_count_vector(size, 4);
+  std::vector<int> f = make_count_vector(size, 5);
+  for (auto _ : state)
+  {
+    auto i = blink::iterator::make_zip_iterator(a.begin(), b.begin(),
+      c.begin(), d.begin(), e.begin(), f.begin());
+    std::int64_t sum = 0;
+    for (std::int64_t n = 0; n < size; ++n, ++i)
+    {
+      sum += std::get<0>(*i) + std::get<1>(*i) + std::get<2>(*i)
+        + std::get<3>(*i) + std::get<4>(*i) + std::get<5>(*i);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_throughput(state, size, 6 * sizeof(int));
+}
+
+// Per-pixel pass over a stack through make_range_zip_range, as in
+// test_range_range. Each outer step advances one iterator per layer.
+void BM_range_zip_range_stack(benchmark::State& state)
+{
+  const int layers = static_cast<int>(state.range(0));
+  const std::int64_t pixels = state.range(1);
+  std::vector<std::vector<int> > stack;
+  for (int k = 0; k < layers; ++k)
+  {
+    stack.push_back(make_count_vector(pixels, k));
+  }
+  auto rr = blink::iterator::make_range_zip_range(std::ref(stack));
+  for (auto _ : state)
+  {
+    std::int64_t total = 0;
+    for (auto&& i : rr)
+    {
+      std::int64_t sum = 0;
+      for (auto&& j : i)
+      {
+        sum += j;
+      }
+      total += sum;
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  set_throughput(state, pixels, layers * sizeof(int));
+}
+
+// The same pass over a pixel-major buffer, the layout a bulk range_range
+// would transpose blocks into
+void BM_pixel_major_stack(benchmark::State& state)
+{
+  const int layers = static_cast<int>(state.range(0));
+  const std::int64_t pixels = state.range(1);
+  std::vector<int> buffer(static_cast<std::size_t>(layers * pixels));
+  for (std::int64_t p = 0; p < pixels; ++p)
+  {
+    for (int k = 0; k < layers; ++k)
+    {
+      buffer[p * layers + k] = static_cast<int>(p) + k;
+    }
+  }
+  for (auto _ : state)
+  {
+    std::int64_t total = 0;
+    for (std::int64_t p = 0; p < pixels; ++p)
+    {
+      const int* pixel = buffer.data() + p * layers;
+      std::int64_t sum = 0;
+      for (int k = 0; k < layers; ++k)
+      {
+        sum += pixel[k];
+      }
+      total += sum;
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  set_throughput(state, pixels, layers * sizeof(int));
+}
+
+// Construct an any_input_iterator and copy it through postfix increment, as
+// in test_any_iterator_postfix
+void BM_any_input_iterator_copy(benchmark::State& state)
+{
+  std::vector<int> v = make_count_vector(16);
+  const std::int64_t allocations_before = allocation_count();
+  for (auto _ : state)
+  {
+    blink::iterator::any_input_iterator<int> i(v.begin());
+    int value = *(i++);
+    benchmark::DoNotOptimize(value);
+  }
+  set_allocations(state, allocation_count() - allocations_before);
+}
+
+// any_proxy_reference holding a value, as in test_any_proxy
+void BM_any_proxy_reference_value(benchmark::State& state)
+{
+  int v = 3;
+  const std::int64_t allocations_before = allocation_count();
+  for (auto _ : state)
+  {
+    blink::iterator::any_proxy_reference<int> a(v);
+    a += 3;
+    int w = a;
+    benchmark::DoNotOptimize(w);
+  }
+  set_allocations(state, allocation_count() - allocations_before);
+}
+
+// The typed baseline for the any_input_range benchmarks
+void BM_vector_sum(benchmark::State& state)
+{
+  const std::int64_t size = state.range(0);
+  std::vector<int> v = make_count_vector(size);
+  for (auto _ : state)
+  {
+    std::int64_t sum = 0;
+    for (auto&& i : v)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_throughput(state, size, sizeof(int));
+}
+
+BENCHMARK_TEMPLATE(BM_range_algebra_vector, plus_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_range_algebra_vector, minus_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_range_algebra_vector, multiplies_op)
+  ->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_range_algebra_vector, divides_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_range_algebra_vector, modulus_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_range_algebra_vector, negate_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_range_algebra_vector, less_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_range_algebra_vector, equal_to_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_range_algebra_vector, compound_op)->Apply(vector_sizes);
+
+BENCHMARK_TEMPLATE(BM_raw_loop_vector, plus_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_raw_loop_vector, minus_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_raw_loop_vector, multiplies_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_raw_loop_vector, divides_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_raw_loop_vector, modulus_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_raw_loop_vector, negate_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_raw_loop_vector, less_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_raw_loop_vector, equal_to_op)->Apply(vector_sizes);
+BENCHMARK_TEMPLATE(BM_raw_loop_vector, compound_op)->Apply(vector_sizes);
+
+BENCHMARK(BM_any_input_range_sum)->Apply(vector_sizes);
+BENCHMARK(BM_any_range_algebra_sum)->Apply(vector_sizes);
+BENCHMARK(BM_vector_sum)->Apply(vector_sizes);
+BENCHMARK(BM_any_input_iterator_copy);
+BENCHMARK(BM_any_proxy_reference_value);
+
+BENCHMARK(BM_zip_iterator_chunks)->Apply(chunk_counts);
+BENCHMARK(BM_transform_range_chunks)->Apply(chunk_counts);
+BENCHMARK(BM_zip_range_sumproduct)->Apply(vector_sizes);
+BENCHMARK(BM_raw_pointer_sumproduct)->Apply(vector_sizes);
+BENCHMARK(BM_zip_range_six_way)->Apply(vector_sizes);
+BENCHMARK(BM_zip_iterator_six_way_counted)->Apply(vector_sizes);
+BENCHMARK(BM_range_zip_range_stack)->Apply(stack_sizes);
+BENCHMARK(BM_pixel_major_stack)->Apply(stack_sizes);
@@ -0,0 +1,1122 @@
+#include <benchmark/benchmark.h>
+
+#include <blink/raster/utility.h>
+#include <blink/raster/gdal_raster_view.h>
+#include <blink/raster/edge_view.h>
+#include <blink/raster/gdal_input_iterator.h>
+#include <blink/raster/offset_raster.h>
+#include <blink/raster/pad_raster.h>
+#include <blink/iterator/range_algebra.h>
+#include <blink/iterator/range_algebra_operators.h>
+#include <blink/iterator/range_range.h>
+#include <blink/iterator/zip_range.h>
+#include <boost/filesystem.hpp>
+
+#include <gdal.h>
+#include <cpl_string.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Raster throughput benchmarks. Each benchmark takes (rows, cols, ...) and
+// reports cells per second (items_per_second) and raster payload per second
+// (bytes_per_second).
+
+namespace {
+
+// Removes the file when leaving scope, also when a benchmark is skipped
+class scratch_file
+{
+public:
+  explicit scratch_file(std::string path) : m_path(std::move(path))
+  {}
+  scratch_file(const scratch_file&) = delete;
+  scratch_file& operator=(const scratch_file&) = delete;
+  ~scratch_file()
+  {
+    boost::filesystem::remove(m_path);
+  }
+  const std::string& path() const
+  {
+    return m_path;
+  }
+private:
+  std::string m_path;
+};
+
+template<class T>
+void write_count_raster(const std::string& path, int rows, int cols,
+  int first = 0)
+{
+  auto r = blink::raster::create_gdal_raster<T>(path, rows, cols);
+  int count = first;
+  for (auto&& i : r)
+  {
+    i = static_cast<T>(count++);
+  }
+} // leave scope, flush to disk
+
+// Square patches of 97 x 97 cells with values from 0 to patch_values - 1, so
+// both v_edge and h_edge views see runs of equal neighbours
+void write_patch_raster(const std::string& path, int rows, int cols,
+  int patch_values)
+{
+  auto r = blink::raster::create_gdal_raster<int>(path, rows, cols);
+  int count = 0;
+  for (auto&& i : r)
+  {
+    const int row = count / cols;
+    const int col = count % cols;
+    i = ((row / 97) * 7 + col / 97) % patch_values;
+    ++count;
+  }
+} // leave scope, flush to disk
+
+// Creates an empty GeoTIFF with GDAL creation options (TILED, BLOCKXSIZE,
+// COMPRESS, ...) that blink::raster::create_gdal_raster does not expose
+void create_geotiff(const std::string& path, int rows, int cols,
+  GDALDataType type, const std::vector<std::string>& options,
+  int band_count = 1)
+{
+  GDALAllRegister();
+  char** papsz_options = nullptr;
+  for (auto&& option : options)
+  {
+    papsz_options = CSLAddString(papsz_options, option.c_str());
+  }
+  GDALDriverH driver = GDALGetDriverByName("GTiff");
+  GDALDatasetH dataset = GDALCreate(driver, path.c_str(), cols, rows,
+    band_count, type, papsz_options);
+  CSLDestroy(papsz_options);
+  GDALClose(dataset);
+}
+
+void write_count_geotiff(const std::string& path, int rows, int cols,
+  const std::vector<std::string>& options)
+{
+  create_geotiff(path, rows, cols, GDT_Int32, options);
+  auto r = blink::raster::open_gdal_raster<int>(path, GA_Update);
+  int count = 0;
+  for (auto&& i : r)
+  {
+    i = count++;
+  }
+} // leave scope, flush to disk
+
+void write_count_tiled_raster(const std::string& path, int rows, int cols,
+  int block_size)
+{
+  const std::string block = std::to_string(block_size);
+  write_count_geotiff(path, rows, cols,
+    { "TILED=YES", "BLOCKXSIZE=" + block, "BLOCKYSIZE=" + block });
+}
+
+// Accumulator wide enough to sum a 20000 x 20000 count raster
+template<class T>
+using sum_type = typename std::conditional<std::is_integral<T>::value,
+  std::int64_t, double>::type;
+
+// Sum of the cells in a tuple of boost::optional that are not empty
+template<class Tuple, std::size_t... I>
+sum_type<int> sum_valid(const Tuple& t, std::index_sequence<I...>)
+{
+  sum_type<int> sum = 0;
+  using expand = int[];
+  (void)expand{ 0, (std::get<I>(t) ? (sum += *std::get<I>(t), 0) : 0)... };
+  return sum;
+}
+
+template<class T>
+void set_throughput(benchmark::State& state, std::int64_t elements,
+  std::int64_t cells)
+{
+  state.SetItemsProcessed(state.iterations() * elements);
+  state.SetBytesProcessed(state.iterations() * cells
+    * static_cast<std::int64_t>(sizeof(T)));
+}
+
+void raster_sizes(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({ "rows", "cols" });
+  b->Args({ 1000, 1000 });
+  b->Args({ 5000, 3000 }); // formerly test_gdal_raster_large
+  b->Args({ 5000, 5000 });
+  b->Args({ 20000, 20000 });
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime(); // I/O bound, CPU time is misleading
+}
+
+// A col_major pass over an untiled raster needs every scanline strip in
+// GDAL's block cache, which col_major_cache provides. At 20000 x 20000 that
+// is 1.6 GB of int and 3.2 GB of double, so these sizes stop at 5000 x 5000.
+void col_major_raster_sizes(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({ "rows", "cols" });
+  b->Args({ 1000, 1000 });
+  b->Args({ 5000, 3000 });
+  b->Args({ 5000, 5000 });
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+void tiled_raster_sizes(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({ "rows", "cols", "block" });
+  b->Args({ 5000, 5000, 256 });
+  b->Args({ 5000, 5000, 512 });
+  b->Args({ 20000, 20000, 256 });
+  b->Args({ 20000, 20000, 512 });
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+// Square focal windows of growing radius, the cost per cell of the naive
+// approach grows with (2r + 1)^2
+void focal_radius_sizes(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({ "rows", "cols", "radius" });
+  b->Args({ 1000, 1000, 1 });
+  b->Args({ 1000, 1000, 2 });
+  b->Args({ 1000, 1000, 5 });
+  b->Args({ 1000, 1000, 10 });
+  b->Args({ 1000, 1000, 50 }); // neighbourhood densities, 10201 reads per cell
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+// Tiled inputs read in lockstep under a GDAL cache budget in MB. One row of
+// 256 x 256 tiles of a 5000 column raster takes 5 MB.
+void raster_stack_sizes(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({ "rows", "cols", "rasters", "cache_mb" });
+  b->Args({ 5000, 5000, 10, 16 });
+  b->Args({ 5000, 5000, 10, 64 });
+  b->Args({ 5000, 5000, 10, 256 });
+  b->Unit(benchmark::kMillisecond);
+  b->UseRealTime();
+}
+
+// From the 5 x 3 rasters of the tests to a typical intermediate result
+void scratch_raster_sizes(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({ "rows", "cols" });
+  b->Args({ 5, 3 });
+  b->Args({ 100, 100 });
+  b->Args({ 1000, 1000 });
+  b->Args({ 5000, 5000 });
+  b->UseRealTime();
+}
+
+// Raises GDAL's block cache (5% of RAM by default) for a col_major pass so
+// that every decoded strip of a rows x cols raster stays resident, and
+// restores the old limit when leaving scope. Other orientations keep the
+// default cache, a row_major pass needs one strip at a time.
+template<class Orientation>
+class col_major_cache
+{
+public:
+  col_major_cache(int rows, int cols, std::size_t cell_bytes)
+    : m_old_bytes(GDALGetCacheMax64())
+  {
+    if (std::is_same<Orientation,
+      blink::raster::orientation::col_major>::value)
+    {
+      const GIntBig decoded_bytes = static_cast<GIntBig>(rows) * cols
+        * static_cast<GIntBig>(cell_bytes);
+      GDALSetCacheMax64(
+        std::max(m_old_bytes, decoded_bytes + (GIntBig{ 64 } << 20)));
+    }
+  }
+  col_major_cache(const col_major_cache&) = delete;
+  col_major_cache& operator=(const col_major_cache&) = delete;
+  ~col_major_cache()
+  {
+    GDALSetCacheMax64(m_old_bytes);
+  }
+private:
+  GIntBig m_old_bytes;
+};
+
+// Byte offset of the pixel data of a single-band, uncompressed GeoTIFF whose
+// strips or tiles are stored contiguously in order, or -1 otherwise
+std::int64_t contiguous_data_offset(const std::string& path)
+{
+  GDALDatasetH dataset = GDALOpen(path.c_str(), GA_ReadOnly);
+  if (!dataset) return -1;
+  GDALRasterBandH band = GDALGetRasterBand(dataset, 1);
+  int block_cols = 0;
+  int block_rows = 0;
+  GDALGetBlockSize(band, &block_cols, &block_rows);
+  const int blocks_x = (GDALGetRasterXSize(dataset) + block_cols - 1)
+    / block_cols;
+  const int blocks_y = (GDALGetRasterYSize(dataset) + block_rows - 1)
+    / block_rows;
+  const std::int64_t block_bytes = std::int64_t{ block_cols } * block_rows
+    * GDALGetDataTypeSizeBytes(GDALGetRasterDataType(band));
+  auto offset = [&](int x, int y) -> std::int64_t {
+    const std::string key = "BLOCK_OFFSET_" + std::to_string(x) + "_"
+      + std::to_string(y);
+    const char* value = GDALGetMetadataItem(band, key.c_str(), "TIFF");
+    return value ? std::atoll(value) : -1;
+  };
+  const std::int64_t first = offset(0, 0);
+  std::int64_t expected = first;
+  for (int y = 0; y < blocks_y && expected >= 0; ++y)
+  {
+    for (int x = 0; x < blocks_x && expected >= 0; ++x)
+    {
+      expected = offset(x, y) == expected ? expected + block_bytes : -1;
+    }
+  }
+  GDALClose(dataset);
+  return expected < 0 ? -1 : first;
+}
+
+// Disjoint sets of provisional patch labels, each set named by its smallest
+// label
+class union_find
+{
+public:
+  int make()
+  {
+    m_parent.push_back(static_cast<int>(m_parent.size()));
+    return m_parent.back();
+  }
+  int find(int x)
+  {
+    while (m_parent[x] != x)
+    {
+      m_parent[x] = m_parent[m_parent[x]]; // path halving
+      x = m_parent[x];
+    }
+    return x;
+  }
+  int unite(int x, int y)
+  {
+    x = find(x);
+    y = find(y);
+    if (y < x) std::swap(x, y);
+    m_parent[y] = x;
+    return x;
+  }
+  int size() const
+  {
+    return static_cast<int>(m_parent.size());
+  }
+private:
+  std::vector<int> m_parent;
+};
+
+// Counts, for each patch, the edges of a v_edge or h_edge view that face
+// another patch or the raster border
+template<class Edges>
+void add_perimeter(Edges&& edges, std::vector<std::int64_t>& perimeter)
+{
+  for (auto&& i : edges)
+  {
+    if (i.first && i.second && *i.first == *i.second) continue;
+    if (i.first) ++perimeter[*i.first];
+    if (i.second) ++perimeter[*i.second];
+  }
+}
+
+} // anonymous namespace
+
+template<class T>
+void BM_gdal_raster_write(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_write.tif");
+  for (auto _ : state)
+  {
+    write_count_raster<T>(file.path(), rows, cols);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<T>(state, cells, cells);
+}
+
+template<class T>
+void BM_gdal_raster_read(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_read.tif");
+  write_count_raster<T>(file.path(), rows, cols);
+  for (auto _ : state)
+  {
+    auto r = blink::raster::open_gdal_raster<T>(file.path(), GA_ReadOnly);
+    sum_type<T> sum = 0;
+    for (auto&& i : r)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<T>(state, cells, cells);
+}
+
+// Scratch raster life cycle: create, fill, read back and discard
+void BM_create_temp_gdal_raster(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  for (auto _ : state)
+  {
+    auto r = blink::raster::create_temp_gdal_raster<int>(rows, cols);
+    int count = 0;
+    for (auto&& i : r)
+    {
+      i = count++;
+    }
+    sum_type<int> sum = 0;
+    for (auto&& i : r)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, 2 * cells);
+}
+
+// The same life cycle in memory, the baseline for an in-memory backend
+void BM_scratch_vector(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  for (auto _ : state)
+  {
+    std::vector<int> r(static_cast<std::size_t>(rows) * cols);
+    int count = 0;
+    for (auto&& i : r)
+    {
+      i = count++;
+    }
+    sum_type<int> sum = 0;
+    for (auto&& i : r)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, 2 * cells);
+}
+
+// Read-only band view over an uncompressed, untiled GeoTIFF, the layout that
+// could be served straight from a memory map. Like gdal_raster_view it reads
+// through RasterIO and the block cache; BM_untiled_geotiff_fread is the floor.
+void BM_gdalrasterband_range_view_read(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_band_read.tif");
+  write_count_raster<int>(file.path(), rows, cols);
+  for (auto _ : state)
+  {
+    auto band = blink::raster::detail::gdal_makers::open_band(file.path(),
+      GA_ReadOnly);
+    blink::raster::gdalrasterband_range_view<const int> view(band);
+    sum_type<int> sum = 0;
+    for (auto&& i : view)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, cells);
+}
+
+// Floor for reading an uncompressed, untiled GeoTIFF: fread of the pixel
+// data straight from the file, without RasterIO or the block cache
+void BM_untiled_geotiff_fread(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_fread.tif");
+  write_count_raster<int>(file.path(), rows, cols);
+  const std::int64_t data_offset = contiguous_data_offset(file.path());
+  if (data_offset < 0)
+  {
+    state.SkipWithError("pixel data is not stored contiguously");
+    return;
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  std::vector<int> buffer(1 << 18);
+  for (auto _ : state)
+  {
+    std::FILE* f = std::fopen(file.path().c_str(), "rb");
+    if (!f)
+    {
+      state.SkipWithError("cannot open file");
+      break;
+    }
+    std::fseek(f, static_cast<long>(data_offset), SEEK_SET);
+    sum_type<int> sum = 0;
+    std::int64_t remaining = cells;
+    while (remaining > 0)
+    {
+      const std::size_t n = static_cast<std::size_t>(std::min<std::int64_t>(
+        remaining, static_cast<std::int64_t>(buffer.size())));
+      if (std::fread(buffer.data(), sizeof(int), n, f) != n) break;
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        sum += buffer[i];
+      }
+      remaining -= static_cast<std::int64_t>(n);
+    }
+    std::fclose(f);
+    if (remaining > 0)
+    {
+      state.SkipWithError("short read of pixel data");
+      break;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_throughput<int>(state, cells, cells);
+}
+
+// One cell of padding around a band view, each cell a boost::optional
+void BM_pad_raster_read(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_pad_read.tif");
+  write_count_raster<int>(file.path(), rows, cols);
+  for (auto _ : state)
+  {
+    auto band = blink::raster::detail::gdal_makers::open_band(file.path(),
+      GA_ReadOnly);
+    blink::raster::gdalrasterband_range_view<const int> view(band);
+    auto padded = blink::raster::pad_raster(view, 1, 1, 1, 1);
+    sum_type<int> sum = 0;
+    for (auto&& i : padded)
+    {
+      if (i) sum += *i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows + 2 } * (cols + 2);
+  set_throughput<int>(state, cells, cells);
+}
+
+// Band view shifted by one row and column, each cell a boost::optional
+void BM_offset_raster_read(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_offset_read.tif");
+  write_count_raster<int>(file.path(), rows, cols);
+  for (auto _ : state)
+  {
+    auto band = blink::raster::detail::gdal_makers::open_band(file.path(),
+      GA_ReadOnly);
+    blink::raster::gdalrasterband_range_view<const int> view(band);
+    auto offset = blink::raster::offset_raster(view, 1, 1);
+    sum_type<int> sum = 0;
+    for (auto&& i : offset)
+    {
+      if (i) sum += *i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, cells);
+}
+
+template<class T>
+void BM_gdal_raster_read_col_major(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_read_col_major.tif");
+  write_count_raster<T>(file.path(), rows, cols);
+  col_major_cache<blink::raster::orientation::col_major> cache(rows, cols,
+    sizeof(T));
+  for (auto _ : state)
+  {
+    auto r = blink::raster::open_gdal_raster<T>(file.path(), GA_ReadOnly);
+    auto t = blink::raster::make_raster_view(
+      &r, blink::raster::orientation::col_major{});
+    sum_type<T> sum = 0;
+    for (auto&& i : t)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<T>(state, cells, cells);
+}
+
+// Tiled GeoTIFF read, the baseline for block order traversal and for
+// staging whole blocks in col_major views
+template<class Orientation>
+void BM_gdal_raster_read_tiled(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  const int block_size = static_cast<int>(state.range(2));
+  scratch_file file("blink_bench_read_tiled.tif");
+  write_count_tiled_raster(file.path(), rows, cols, block_size);
+  for (auto _ : state)
+  {
+    auto r = blink::raster::open_gdal_raster<int>(file.path(), GA_ReadOnly);
+    auto t = blink::raster::make_raster_view(&r, Orientation{});
+    sum_type<int> sum = 0;
+    for (auto&& i : t)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, cells);
+}
+
+// Bulk fill through the cell iterators
+void BM_gdal_raster_fill(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_fill.tif");
+  write_count_raster<int>(file.path(), rows, cols);
+  for (auto _ : state)
+  {
+    auto r = blink::raster::open_gdal_raster<int>(file.path(), GA_Update);
+    for (auto&& i : r)
+    {
+      i = 7;
+    }
+  } // leave scope, flush to disk
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, cells);
+}
+
+// Bulk copy of one raster into another through a zip_range
+void BM_gdal_raster_copy(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file_in("blink_bench_copy_in.tif");
+  scratch_file file_out("blink_bench_copy_out.tif");
+  write_count_raster<int>(file_in.path(), rows, cols);
+  write_count_raster<int>(file_out.path(), rows, cols);
+  for (auto _ : state)
+  {
+    auto in = blink::raster::open_gdal_raster<int>(file_in.path(),
+      GA_ReadOnly);
+    auto out = blink::raster::open_gdal_raster<int>(file_out.path(),
+      GA_Update);
+    auto z = blink::iterator::make_zip_range(std::ref(out), std::ref(in));
+    for (auto&& i : z)
+    {
+      std::get<0>(i) = std::get<1>(i);
+    }
+  } // leave scope, flush to disk
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, 2 * cells);
+}
+
+// DEFLATE-compressed GeoTIFF read, where decoding competes with compute on
+// the iterating thread. Under col_major_cache a col_major pass decodes each
+// strip once, as BM_gdal_raster_read_col_major reads each strip once.
+template<class Orientation>
+void BM_gdal_raster_read_deflate(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_read_deflate.tif");
+  write_count_geotiff(file.path(), rows, cols, { "COMPRESS=DEFLATE" });
+  col_major_cache<Orientation> cache(rows, cols, sizeof(int));
+  for (auto _ : state)
+  {
+    auto r = blink::raster::open_gdal_raster<int>(file.path(), GA_ReadOnly);
+    auto t = blink::raster::make_raster_view(&r, Orientation{});
+    sum_type<int> sum = 0;
+    for (auto&& i : t)
+    {
+      sum += i;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, cells);
+}
+
+// Fill of a DEFLATE-compressed GeoTIFF, where blocks are compressed and
+// written on the iterating thread at eviction and close
+void BM_gdal_raster_write_deflate(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_write_deflate.tif");
+  for (auto _ : state)
+  {
+    write_count_geotiff(file.path(), rows, cols, { "COMPRESS=DEFLATE" });
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, cells);
+}
+
+// Three-band pixel-interleaved GeoTIFF, read the current way by opening
+// each band separately and zipping the band views
+void BM_multi_band_zip_read(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_multi_band.tif");
+  create_geotiff(file.path(), rows, cols, GDT_Int32, { "INTERLEAVE=PIXEL" },
+    3);
+  for (int b = 1; b <= 3; ++b)
+  {
+    auto band = blink::raster::detail::gdal_makers::open_band(file.path(),
+      GA_Update, b);
+    blink::raster::gdalrasterband_range_view<int> view(band);
+    int count = 0;
+    for (auto&& i : view)
+    {
+      i = b * count++;
+    }
+  }
+  for (auto _ : state)
+  {
+    auto band_1 = blink::raster::detail::gdal_makers::open_band(file.path(),
+      GA_ReadOnly, 1);
+    auto band_2 = blink::raster::detail::gdal_makers::open_band(file.path(),
+      GA_ReadOnly, 2);
+    auto band_3 = blink::raster::detail::gdal_makers::open_band(file.path(),
+      GA_ReadOnly, 3);
+    blink::raster::gdalrasterband_range_view<const int> view_1(band_1);
+    blink::raster::gdalrasterband_range_view<const int> view_2(band_2);
+    blink::raster::gdalrasterband_range_view<const int> view_3(band_3);
+    auto z = blink::iterator::make_zip_range(std::ref(view_1),
+      std::ref(view_2), std::ref(view_3));
+    sum_type<int> sum = 0;
+    for (auto&& i : z)
+    {
+      sum += std::get<0>(i);
+      sum += std::get<1>(i);
+      sum += std::get<2>(i);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, 3 * cells);
+}
+
+// Lockstep read of several tiled rasters sharing GDAL's block cache
+void BM_gdal_raster_stack_read(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  const int raster_count = static_cast<int>(state.range(2));
+  const GIntBig cache_bytes = static_cast<GIntBig>(state.range(3)) << 20;
+  std::vector<std::unique_ptr<scratch_file> > files;
+  for (int k = 0; k < raster_count; ++k)
+  {
+    files.emplace_back(new scratch_file(
+      "blink_bench_stack_" + std::to_string(k) + ".tif"));
+    write_count_tiled_raster(files.back()->path(), rows, cols, 256);
+  }
+  const GIntBig old_cache_bytes = GDALGetCacheMax64();
+  GDALSetCacheMax64(cache_bytes);
+  for (auto _ : state)
+  {
+    using view_type = decltype(
+      blink::raster::open_gdal_raster<int>(std::string{}, GA_ReadOnly));
+    std::vector<view_type> views;
+    for (auto&& file : files)
+    {
+      views.emplace_back(
+        blink::raster::open_gdal_raster<int>(file->path(), GA_ReadOnly));
+    }
+    auto rr = blink::iterator::make_range_zip_range(std::ref(views));
+    sum_type<int> sum = 0;
+    for (auto&& i : rr)
+    {
+      for (auto&& j : i)
+      {
+        sum += j;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  GDALSetCacheMax64(old_cache_bytes);
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, raster_count * cells);
+}
+
+// 3 x 3 focal sum built the current way, by zipping nine offset views
+void BM_focal_sum_offset_zip(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_focal.tif");
+  write_count_raster<int>(file.path(), rows, cols);
+  for (auto _ : state)
+  {
+    auto band = blink::raster::detail::gdal_makers::open_band(file.path(),
+      GA_ReadOnly);
+    blink::raster::gdalrasterband_range_view<const int> view(band);
+    auto z = blink::iterator::make_zip_range(
+      blink::raster::offset_raster(view, -1, -1),
+      blink::raster::offset_raster(view, -1, 0),
+      blink::raster::offset_raster(view, -1, 1),
+      blink::raster::offset_raster(view, 0, -1),
+      blink::raster::offset_raster(view, 0, 0),
+      blink::raster::offset_raster(view, 0, 1),
+      blink::raster::offset_raster(view, 1, -1),
+      blink::raster::offset_raster(view, 1, 0),
+      blink::raster::offset_raster(view, 1, 1));
+    sum_type<int> sum = 0;
+    for (auto&& i : z)
+    {
+      sum += sum_valid(i, std::make_index_sequence<9>{});
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, cells);
+}
+
+// Square focal sum of any radius over a range_zip_range of offset views
+void BM_focal_sum_offset_range_zip(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  const int radius = static_cast<int>(state.range(2));
+  scratch_file file("blink_bench_focal_radius.tif");
+  write_count_raster<int>(file.path(), rows, cols);
+  for (auto _ : state)
+  {
+    auto band = blink::raster::detail::gdal_makers::open_band(file.path(),
+      GA_ReadOnly);
+    blink::raster::gdalrasterband_range_view<const int> view(band);
+    std::vector<decltype(blink::raster::offset_raster(view, 0, 0))> offsets;
+    for (int dr = -radius; dr <= radius; ++dr)
+    {
+      for (int dc = -radius; dc <= radius; ++dc)
+      {
+        offsets.emplace_back(blink::raster::offset_raster(view, dr, dc));
+      }
+    }
+    auto rr = blink::iterator::make_range_zip_range(std::ref(offsets));
+    sum_type<int> sum = 0;
+    for (auto&& i : rr)
+    {
+      for (auto&& j : i)
+      {
+        if (j) sum += *j;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, cells);
+  state.counters["window_cells"] = (2 * radius + 1) * (2 * radius + 1);
+}
+
+// Zonal statistics (count, sum, min, max) of a value raster over a raster of
+// 50 zones, hand-written over a zip_range as is done today
+void BM_zonal_statistics(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  const int zone_count = 50;
+  scratch_file file_zones("blink_bench_zones.tif");
+  scratch_file file_values("blink_bench_zone_values.tif");
+  {
+    auto r = blink::raster::create_gdal_raster<int>(file_zones.path(), rows,
+      cols);
+    int count = 0;
+    for (auto&& i : r)
+    {
+      i = (count++ / 97) % zone_count; // runs of cells in the same zone
+    }
+  } // leave scope, flush to disk
+  write_count_raster<int>(file_values.path(), rows, cols);
+
+  struct zone_stats
+  {
+    std::int64_t count = 0;
+    sum_type<int> sum = 0;
+    int min = std::numeric_limits<int>::max();
+    int max = std::numeric_limits<int>::lowest();
+  };
+  for (auto _ : state)
+  {
+    auto zones = blink::raster::open_gdal_raster<int>(file_zones.path(),
+      GA_ReadOnly);
+    auto values = blink::raster::open_gdal_raster<int>(file_values.path(),
+      GA_ReadOnly);
+    std::vector<zone_stats> stats(zone_count);
+    auto z = blink::iterator::make_zip_range(std::ref(zones),
+      std::ref(values));
+    for (auto&& i : z)
+    {
+      zone_stats& s = stats[std::get<0>(i)];
+      const int value = std::get<1>(i);
+      ++s.count;
+      s.sum += value;
+      s.min = std::min(s.min, value);
+      s.max = std::max(s.max, value);
+    }
+    benchmark::DoNotOptimize(stats.data());
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, 2 * cells);
+}
+
+// Map algebra over two rasters, as in test_range_algebra_operators
+void BM_gdal_raster_range_algebra(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file_a("blink_bench_algebra_a.tif");
+  scratch_file file_b("blink_bench_algebra_b.tif");
+  scratch_file file_out("blink_bench_algebra_out.tif");
+  write_count_raster<int>(file_a.path(), rows, cols);
+  write_count_raster<int>(file_b.path(), rows, cols, 1); // divisor
+  write_count_raster<int>(file_out.path(), rows, cols);
+  for (auto _ : state)
+  {
+    auto a = blink::raster::open_gdal_raster<int>(file_a.path(), GA_ReadOnly);
+    auto b = blink::raster::open_gdal_raster<int>(file_b.path(), GA_ReadOnly);
+    auto out = blink::raster::open_gdal_raster<int>(file_out.path(),
+      GA_Update);
+    auto ra = blink::iterator::range_algebra_ref(a);
+    auto rb = blink::iterator::range_algebra_ref(b);
+    auto rout = blink::iterator::range_algebra_ref(out);
+    rout = -ra + 5 * rb - ra * 3 / rb + ra % 7;
+  } // leave scope, flush output
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, 3 * cells); // two inputs, one output
+}
+
+// Items are edges, bytes are the cells of the underlying raster
+template<class T, class Element>
+void BM_gdal_raster_read_edge(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_read_edge.tif");
+  write_count_raster<T>(file.path(), rows, cols);
+  std::int64_t edges = 0;
+  for (auto _ : state)
+  {
+    auto r = blink::raster::open_gdal_raster<T>(file.path(), GA_ReadOnly);
+    auto t = blink::raster::make_raster_view(
+      &r, blink::raster::orientation::row_major{}, Element{});
+    edges = 0;
+    sum_type<T> sum = 0;
+    for (auto&& i : t)
+    {
+      if (i.first) sum += *i.first;
+      ++edges;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_throughput<T>(state, edges, std::int64_t{ rows } * cols);
+}
+
+// Patch boundary length and gradient: the number of edges whose sides
+// differ and the sum of |a - b| over edges with two sides
+template<class Element>
+void BM_edge_boundary_reduction(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_edge_boundary.tif");
+  write_patch_raster(file.path(), rows, cols, 50);
+  std::int64_t edges = 0;
+  for (auto _ : state)
+  {
+    auto r = blink::raster::open_gdal_raster<int>(file.path(), GA_ReadOnly);
+    auto t = blink::raster::make_raster_view(
+      &r, blink::raster::orientation::row_major{}, Element{});
+    edges = 0;
+    std::int64_t boundary = 0;
+    sum_type<int> gradient = 0;
+    for (auto&& i : t)
+    {
+      if (i.first && i.second)
+      {
+        boundary += (*i.first != *i.second);
+        gradient += std::abs(*i.first - *i.second);
+      }
+      ++edges;
+    }
+    benchmark::DoNotOptimize(boundary);
+    benchmark::DoNotOptimize(gradient);
+  }
+  set_throughput<int>(state, edges, std::int64_t{ rows } * cols);
+}
+
+// Patch labelling written by hand as is done today, the baseline for a
+// library labeller. The first pass assigns provisional labels from the
+// previous row and unites equal neighbours, the second resolves the labels
+// and counts patch areas, and the v_edge and h_edge views over the labels
+// give patch perimeters. Items and bytes are the cells of the input raster.
+template<int Connectivity>
+void BM_patch_labelling(benchmark::State& state)
+{
+  const int rows = static_cast<int>(state.range(0));
+  const int cols = static_cast<int>(state.range(1));
+  scratch_file file("blink_bench_patches.tif");
+  write_patch_raster(file.path(), rows, cols, 50);
+  int patch_count = 0;
+  for (auto _ : state)
+  {
+    auto values = blink::raster::open_gdal_raster<int>(file.path(),
+      GA_ReadOnly);
+    auto labels = blink::raster::create_temp_gdal_raster<int>(rows, cols);
+    union_find sets;
+    std::vector<int> prev_values(cols);
+    std::vector<int> prev_labels(cols);
+    std::vector<int> cur_values(cols);
+    std::vector<int> cur_labels(cols);
+    std::int64_t count = 0;
+    auto z = blink::iterator::make_zip_range(std::ref(values),
+      std::ref(labels));
+    for (auto&& i : z)
+    {
+      const std::int64_t row = count / cols;
+      const int col = static_cast<int>(count % cols);
+      const int value = std::get<0>(i);
+      int label = -1;
+      auto join = [&](int neighbour_value, int neighbour_label) {
+        if (neighbour_value != value) return;
+        label = label < 0 ? sets.find(neighbour_label)
+          : sets.unite(label, neighbour_label);
+      };
+      if (col > 0) join(cur_values[col - 1], cur_labels[col - 1]);
+      if (row > 0)
+      {
+        join(prev_values[col], prev_labels[col]);
+        if (Connectivity == 8 && col > 0)
+        {
+          join(prev_values[col - 1], prev_labels[col - 1]);
+        }
+        if (Connectivity == 8 && col + 1 < cols)
+        {
+          join(prev_values[col + 1], prev_labels[col + 1]);
+        }
+      }
+      if (label < 0) label = sets.make();
+      cur_values[col] = value;
+      cur_labels[col] = label;
+      std::get<1>(i) = label;
+      if (col + 1 == cols)
+      {
+        std::swap(prev_values, cur_values);
+        std::swap(prev_labels, cur_labels);
+      }
+      ++count;
+    }
+
+    // Roots are the smallest label of their set, so they are numbered
+    // before the labels that point to them
+    std::vector<int> patch_of(sets.size());
+    patch_count = 0;
+    for (int k = 0; k < sets.size(); ++k)
+    {
+      const int root = sets.find(k);
+      patch_of[k] = root == k ? patch_count++ : patch_of[root];
+    }
+    std::vector<std::int64_t> area(patch_count, 0);
+    for (auto&& i : labels)
+    {
+      i = patch_of[i];
+      ++area[i];
+    }
+
+    std::vector<std::int64_t> perimeter(patch_count, 0);
+    add_perimeter(blink::raster::make_raster_view(&labels,
+      blink::raster::orientation::row_major{},
+      blink::raster::element::v_edge{}), perimeter);
+    add_perimeter(blink::raster::make_raster_view(&labels,
+      blink::raster::orientation::row_major{},
+      blink::raster::element::h_edge{}), perimeter);
+    benchmark::DoNotOptimize(area.data());
+    benchmark::DoNotOptimize(perimeter.data());
+  }
+  const std::int64_t cells = std::int64_t{ rows } * cols;
+  set_throughput<int>(state, cells, cells);
+  state.counters["patches"] = patch_count;
+}
+
+BENCHMARK_TEMPLATE(BM_gdal_raster_write, int)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_write, float)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_write, double)->Apply(raster_sizes);
+
+BENCHMARK_TEMPLATE(BM_gdal_raster_read, int)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_read, float)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_read, double)->Apply(raster_sizes);
+
+BENCHMARK(BM_create_temp_gdal_raster)->Apply(scratch_raster_sizes);
+BENCHMARK(BM_scratch_vector)->Apply(scratch_raster_sizes);
+
+BENCHMARK(BM_gdalrasterband_range_view_read)->Apply(raster_sizes);
+BENCHMARK(BM_untiled_geotiff_fread)->Apply(raster_sizes);
+BENCHMARK(BM_pad_raster_read)->Apply(raster_sizes);
+BENCHMARK(BM_offset_raster_read)->Apply(raster_sizes);
+
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_tiled,
+  blink::raster::orientation::row_major)->Apply(tiled_raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_tiled,
+  blink::raster::orientation::col_major)->Apply(tiled_raster_sizes);
+
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_deflate,
+  blink::raster::orientation::row_major)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_deflate,
+  blink::raster::orientation::col_major)->Apply(col_major_raster_sizes);
+
+BENCHMARK(BM_gdal_raster_write_deflate)->Apply(raster_sizes);
+
+BENCHMARK(BM_gdal_raster_stack_read)->Apply(raster_stack_sizes);
+BENCHMARK(BM_multi_band_zip_read)->Apply(raster_sizes);
+
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_col_major, int)
+  ->Apply(col_major_raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_col_major, float)
+  ->Apply(col_major_raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_col_major, double)
+  ->Apply(col_major_raster_sizes);
+
+BENCHMARK(BM_gdal_raster_fill)->Apply(raster_sizes);
+BENCHMARK(BM_gdal_raster_copy)->Apply(raster_sizes);
+BENCHMARK(BM_gdal_raster_range_algebra)->Apply(raster_sizes);
+BENCHMARK(BM_zonal_statistics)->Apply(raster_sizes);
+BENCHMARK(BM_focal_sum_offset_zip)->Apply(raster_sizes);
+BENCHMARK(BM_focal_sum_offset_range_zip)->Apply(focal_radius_sizes);
+
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_edge, int,
+  blink::raster::element::v_edge)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_edge, int,
+  blink::raster::element::h_edge)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_edge, double,
+  blink::raster::element::v_edge)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_gdal_raster_read_edge, double,
+  blink::raster::element::h_edge)->Apply(raster_sizes);
+
+BENCHMARK_TEMPLATE(BM_edge_boundary_reduction,
+  blink::raster::element::v_edge)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_edge_boundary_reduction,
+  blink::raster::element::h_edge)->Apply(raster_sizes);
+
+BENCHMARK_TEMPLATE(BM_patch_labelling, 4)->Apply(raster_sizes);
+BENCHMARK_TEMPLATE(BM_patch_labelling, 8)->Apply(raster_sizes);